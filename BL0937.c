@@ -11,24 +11,72 @@ static BL0937_model_t _model;
 
 static BL0937_data_t *_cf0=NULL;
 static BL0937_data_t *_cf1=NULL;
+static uint32_t _cf0_rejected=0; //pulses that arrived while no dataset was armed
+static uint32_t _cf1_rejected=0;
 // SemaphoreHandle_t   semaphore;  //must set
 // uint32_t            mintime;    //must set in microseconds
+// uint32_t            period;     //must set mains period in microseconds, 0 = no alignment
 // uint32_t            total;      //does not clear
+// uint32_t            burst;      //does not clear
+// uint32_t            cycle;      //does not clear
+// bool                steady;     //does not clear
 // uint32_t            to_count;   //autoinit
 // uint32_t            count;      //autoinit
 // uint32_t            now;        //autoinit
 // uint32_t            time[BL0937_N]; //autoinit
+// uint32_t            target;     //autoinit
+// uint32_t            interval;   //autoinit
+// uint32_t            bursts;     //autoinit
+// uint32_t            burst_count[2]; //autoinit
+// uint32_t            burst_time[2];  //autoinit
+// uint32_t            pulses;     //autoinit
+// uint32_t            span;       //autoinit
 
 static void  IRAM _interrupt_handler(uint8_t gpio_num) {
     BL0937_data_t   *cf=(gpio_num==_cf0_pin)?_cf0:_cf1;
     BaseType_t   yield = pdFALSE;
+    uint32_t     now, last, delta, whole, cycle;
     if (cf) {
         cf->total++;
-        cf->now=sdk_system_get_time();
-        if (cf->count  < BL0937_N) cf->time[cf->count]=cf->now;
-        if (cf->count++> BL0937_N-2 && (cf->now-cf->time[0])>cf->mintime) xSemaphoreGiveFromISR(cf->semaphore,&yield);
+        now=sdk_system_get_time();
+        last=cf->now;
+        if (cf->count) {
+            delta=now-last;
+            if (cf->period && cf->interval && delta>cf->period && delta>4*cf->interval) { //burst-fire load starts a new burst
+                if (!cf->bursts++) {cf->burst_count[0]=cf->count; cf->burst_time[0]=now;}
+                cf->burst_count[1]=cf->count; cf->burst_time[1]=now;
+                cycle=now-cf->burst; //two equal cycles in a row make a burst-fire pattern, a single gap is just a load step
+                cf->steady=(cf->burst && (cycle>cf->cycle?cycle-cf->cycle:cf->cycle-cycle)<=cf->period);
+                cf->cycle=cycle;
+                cf->burst=now;
+            }
+            cf->interval=delta;
+        }
+        cf->now=now;
+        if (cf->count  < BL0937_N) cf->time[cf->count]=now;
+        if (cf->count++> BL0937_N-2 && !cf->pulses) { //window still open
+            if (cf->bursts>1 && cf->burst_time[1]==now) { //close on a burst start, so it spans whole bursts
+                if ((now-cf->burst_time[0])>=cf->target) {
+                    cf->span  =now-cf->burst_time[0];
+                    cf->pulses=cf->burst_count[1]-cf->burst_count[0];
+                }
+            } else if ((now-cf->time[0])>=cf->target && (!cf->bursts || (now-cf->burst_time[1])>cf->target)
+                                                      && (!cf->steady || (now-cf->burst)>cf->cycle+cf->period)) { //continuous load or the bursts stopped
+                cf->bursts=0; //a burst older than target belongs to a previous load
+                cf->span  =now-cf->time[0];
+                cf->pulses=cf->count-1;
+                if (cf->period && cf->count>BL0937_N) { //end on the pulse nearest to whole mains periods after time[0]
+                    whole=(cf->span+cf->period/2)/cf->period*cf->period;
+                    if (whole<cf->span && (last-cf->time[0]>=whole || whole-(last-cf->time[0])<cf->span-whole)) {
+                        cf->span  =last-cf->time[0];
+                        cf->pulses=cf->count-2;
+                    }
+                }
+            }
+            if (cf->pulses) xSemaphoreGiveFromISR(cf->semaphore,&yield);
+        }
         if (yield) taskYIELD();
-    }
+    } else if (gpio_num==_cf0_pin) _cf0_rejected++; else _cf1_rejected++;
 }
 
 void BL0937_init(uint8_t cf_pin, uint8_t cf1_pin, uint8_t sel_pin, BL0937_model_t model) {
@@ -57,6 +105,10 @@ void BL0937_collect(BL0937_source_t source, BL0937_data_t *data) {
             data->count=0;
             data->now=0;
             for (int i=0; i<BL0937_N; i++) data->time[i]=0;
+            data->target=(data->period)?((data->mintime+data->period-1)/data->period)*data->period:data->mintime;
+            data->interval=0;
+            data->bursts=0;
+            data->pulses=0;
             xSemaphoreTake(data->semaphore,0); //eat the semaphore in case it triggered already
             _cf0=data; //ready to go
         } else { //SOURCE_CF1x
@@ -65,6 +117,10 @@ void BL0937_collect(BL0937_source_t source, BL0937_data_t *data) {
             data->count=0;
             data->now=0;
             for (int i=0; i<BL0937_N; i++) data->time[i]=0;
+            data->target=(data->period)?((data->mintime+data->period-1)/data->period)*data->period:data->mintime;
+            data->interval=0;
+            data->bursts=0;
+            data->pulses=0;
             gpio_write(_sel_pin, (source==SOURCE_CF1A)?0:1); //TODO: make model dependant
             sdk_os_delay_us(12);//wait >10 microseconds
             xSemaphoreTake(data->semaphore,0); //eat the semaphore in case it triggered already
@@ -73,6 +129,27 @@ void BL0937_collect(BL0937_source_t source, BL0937_data_t *data) {
     } else printf("ERROR: Must set semaphore!\n");
 }
 
+uint32_t BL0937_window(BL0937_data_t *data, uint32_t *span) {
+    if (data->pulses) { //closed by the interrupt
+        *span=data->span;
+        return data->pulses;
+    }
+    if (data->bursts>1 && data->burst_count[1]>data->burst_count[0] && (data->now-data->burst_time[1])<=data->target) { //whole bursts so far
+        *span=data->burst_time[1]-data->burst_time[0];
+        return data->burst_count[1]-data->burst_count[0];
+    }
+    if (data->count>1) { //timed out, first pulse up to the latest
+        *span=data->now-data->time[0];
+        return data->count-1;
+    }
+    *span=0;
+    return 0;
+}
+
+uint32_t BL0937_rejected(BL0937_source_t source) {
+    return (source==SOURCE_CF)?_cf0_rejected:_cf1_rejected;
+}
+
 bool BL0937_process(BL0937_data_t *data, BaseType_t taken) {
     int shift,i,j;
     if (taken) { //implies that BL0937_N values are loaded
@@ -85,6 +162,13 @@ bool BL0937_process(BL0937_data_t *data, BaseType_t taken) {
                 }
             }
             data->count-=shift;
+            if (data->bursts) { //keep burst markers relative to the shifted count
+                if (data->burst_count[0]>=(uint32_t)shift) {
+                    data->burst_count[0]-=shift;
+                    data->burst_count[1]-=shift;
+                } else data->bursts=0;
+            }
+            data->pulses=0; //reopen the window on the shifted values
             data->to_count=0; //TODO: maybe only decrease a bit?
         } else return true; //toc==0, speedy enough, start over
     } else { //timed out
@@ -24,11 +24,22 @@ typedef enum {
 typedef struct {
     SemaphoreHandle_t   semaphore;  //must set
     uint32_t            mintime;    //must set in microseconds
+    uint32_t            period;     //must set mains period in microseconds, 0 = no alignment
     uint32_t            total;      //does not clear
+    uint32_t            burst;      //does not clear time of the latest burst start
+    uint32_t            cycle;      //does not clear time between the latest two burst starts
+    bool                steady;     //does not clear the latest two cycles matched within a mains period
     uint32_t            to_count;   //autoinit
     uint32_t            count;      //autoinit
     uint32_t            now;        //autoinit
     uint32_t            time[BL0937_N]; //autoinit
+    uint32_t            target;     //autoinit mintime rounded up to whole mains periods, windows end on the pulse nearest to it
+    uint32_t            interval;   //autoinit latest pulse interval
+    uint32_t            bursts;     //autoinit burst starts seen (first pulse after whole mains cycles of silence)
+    uint32_t            burst_count[2]; //autoinit count at the first and the latest burst start
+    uint32_t            burst_time[2];  //autoinit
+    uint32_t            pulses;     //autoinit pulse intervals in the window the interrupt closed, 0 = still open
+    uint32_t            span;       //autoinit its length in us
 } BL0937_data_t;
 
 void BL0937_init(uint8_t cf_pin, uint8_t cf1_pin, uint8_t sel_pin, BL0937_model_t model);
@@ -37,5 +48,9 @@ void BL0937_collect(BL0937_source_t source, BL0937_data_t *data);
 
 bool BL0937_process(BL0937_data_t *data, BaseType_t taken);
 
+uint32_t BL0937_window(BL0937_data_t *data, uint32_t *span); //pulse intervals in the window, whole bursts if seen, and its span in us
+
+uint32_t BL0937_rejected(BL0937_source_t source); //pulses lost while a dataset was being (re)armed
+
 
 #endif
@@ -0,0 +1,33 @@
+#include <stdio.h>
+#include <FreeRTOS.h>
+#include <task.h>
+#include <budget.h>
+
+budget_t budget[BUDGET_N] = {
+    [BUDGET_CF0]       = {.name="CF0_task",     .stack=CF0_STACK,       .heap_min=UINT32_MAX},
+    [BUDGET_CF1]       = {.name="CF1_task",     .stack=CF1_STACK,       .heap_min=UINT32_MAX},
+    [BUDGET_TIMER]     = {.name="Tmr Svc",      .stack=configTIMER_TASK_STACK_DEPTH, .heap_min=UINT32_MAX},
+    [BUDGET_METRICS]   = {.name="metrics_task", .stack=METRICS_STACK,   .heap_min=UINT32_MAX},
+};
+
+static uint32_t _heap_min=0; //0 = not yet recorded
+
+void budget_record(budget_slot_t slot) {
+    uint32_t heap=xPortGetFreeHeapSize();
+    budget[slot].stack_free=uxTaskGetStackHighWaterMark(NULL);
+    if (heap<budget[slot].heap_min) budget[slot].heap_min=heap;
+    if (!_heap_min || heap<_heap_min) _heap_min=heap;
+}
+
+uint32_t budget_heap_min(void) {
+    return _heap_min;
+}
+
+void budget_report(void) { //lines are parsed by budget_report.py, keep the format stable
+    for (int i=0; i<BUDGET_N; i++) {
+        if (!budget[i].stack_free) continue;
+        printf("BUDGET task=%s stack=%u free=%u heapmin=%u\n",budget[i].name,budget[i].stack,budget[i].stack_free,budget[i].heap_min);
+    }
+    if (_heap_min) printf("BUDGET heap=%u heapmin=%u\n",(uint32_t)xPortGetFreeHeapSize(),_heap_min);
+    else printf("BUDGET heap=%u\n",(uint32_t)xPortGetFreeHeapSize());
+}
@@ -0,0 +1,44 @@
+#ifndef budget_h
+#define budget_h
+
+#include <stdint.h>
+
+// stack sizes in words, override from the Makefile once budget_report.py has seen a representative load
+#ifndef CF0_STACK
+#define CF0_STACK 512
+#endif
+#ifndef CF1_STACK
+#define CF1_STACK 512
+#endif
+#ifndef METRICS_STACK
+#define METRICS_STACK 512
+#endif
+
+#ifndef BUDGET_REPORT_INTERVAL
+#define BUDGET_REPORT_INTERVAL 600000 //milliseconds
+#endif
+
+typedef enum {
+    BUDGET_CF0 = 0,
+    BUDGET_CF1,
+    BUDGET_TIMER,       //FreeRTOS timer task, runs the ETSTimer callbacks like calibration
+    BUDGET_METRICS,
+    BUDGET_N
+} budget_slot_t;
+
+typedef struct {
+    const char          *name;
+    uint32_t            stack;      //allocated words
+    uint32_t            stack_free; //high-water mark in words, 0 = not yet recorded
+    uint32_t            heap_min;   //lowest free heap seen by this task in bytes
+} budget_t;
+
+extern budget_t budget[BUDGET_N];
+
+void budget_record(budget_slot_t slot); //call from the task itself
+
+uint32_t budget_heap_min(void); //lowest free heap any task recorded, 0 = none yet
+
+void budget_report(void);
+
+#endif
@@ -0,0 +1,42 @@
+#!/usr/bin/env python3
+# Summarise the BUDGET lines of one or more NAS-WR01W plugs into stack sizing advice.
+# Feed it UDPlogger output, e.g.:  nc -kulnw0 45678 | tee budget.log  then  ./budget_report.py budget.log
+# A line may carry a prefix (ip, timestamp), only the part from BUDGET onwards is used.
+
+import re
+import sys
+
+MARGIN = 1.25   # keep a quarter of the used stack as headroom
+ROUND  = 32     # words
+
+tasks = {}      # name -> (allocated words, lowest free words, lowest heap)
+heap_min = None
+
+for source in (open(f) for f in sys.argv[1:]) if sys.argv[1:] else [sys.stdin]:
+    for text in source:
+        m = re.search(r'BUDGET (.*)', text)
+        if not m:
+            continue
+        fields = dict(kv.split('=', 1) for kv in m.group(1).split() if '=' in kv)
+        try:
+            if 'task' in fields:
+                stack, free, heap = int(fields['stack']), int(fields['free']), int(fields['heapmin'])
+                old = tasks.get(fields['task'], (stack, free, heap))
+                tasks[fields['task']] = (stack, min(free, old[1]), min(heap, old[2]))
+            elif 'heapmin' in fields:
+                heap = int(fields['heapmin'])
+                heap_min = heap if heap_min is None else min(heap_min, heap)
+        except (KeyError, ValueError):
+            continue
+
+if not tasks:
+    sys.exit('no BUDGET lines found')
+
+print('%-14s %8s %8s %8s %10s' % ('task', 'stack', 'used', 'advice', 'heapmin'))
+for name, (stack, free, heap) in sorted(tasks.items()):
+    used = stack - free
+    advice = -(-int(used * MARGIN) // ROUND) * ROUND
+    print('%-14s %8d %8d %8d %10d' % (name, stack, used, advice, heap))
+if heap_min is not None:
+    print('lowest free heap seen: %d bytes' % heap_min)
+print('apply with e.g.  EXTRA_CFLAGS += -DCF0_STACK=<advice>')
@@ -37,6 +37,8 @@
 #include <udplogger.h>
 #include <etstimer.h>
 #include <BL0937.h>
+#include <metrics.h>
+#include <budget.h>
 
 /* ============== BEGIN HOMEKIT CHARACTERISTIC DECLARATIONS =============================================================== */
 // add this section to make your device OTA capable
@@ -79,59 +81,73 @@ const int LED_GPIO    = 13;
 const int relay_gpio  = 14;
 
 ETSTimer save_timer;
-void homekit_characteristic_bounds_check(homekit_characteristic_t *ch) {
-    printf ("%s: %s: ",__func__, ch->description);
-    switch (ch->format) {
-        case homekit_format_bool:
-            printf ("Checking boolean bounds");
-            if ((ch->value.bool_value != 0) && (ch->value.bool_value != 1)){
-                printf (" Out of bounds setting to false");
-                ch->value.bool_value = false;
+ETSTimer calibrate_timer;
+// bounds of the measured characteristics, resolved once from accessories[] into scaled integers
+// so the measurement loops clamp with plain integer compares and only notify real changes
+#define BOUNDS_N 8
+typedef struct {
+    homekit_characteristic_t *ch;
+    uint32_t            scale;  //integer steps per unit, from min_step
+    int64_t             min;    //signed, a declared bound may be negative
+    int64_t             max;
+    int64_t             last;   //last stored value in steps
+    bool                is_float;
+} bounds_t;
+
+extern homekit_accessory_t *accessories[];
+bounds_t  bounds[BOUNDS_N];
+int       bounds_n=0;
+bounds_t *watts_bounds, *volts_bounds, *mamps_bounds, *mWhs_bounds;
+
+void bounds_resolve(void) { //every numeric characteristic that HomeKit can read but not write is a measurement
+    homekit_characteristic_t *ch;
+    bounds_t *b;
+    int64_t lo, hi;
+    for (homekit_accessory_t **acc=accessories; *acc; acc++) {
+        for (homekit_service_t **svc=(*acc)->services; *svc; svc++) {
+            for (homekit_characteristic_t **chp=(*svc)->characteristics; *chp; chp++) {
+                ch=*chp;
+                if (ch->permissions & homekit_permissions_paired_write) continue;
+                switch (ch->format) { //the native range of the format
+                    case homekit_format_uint8:  lo=0;         hi=UINT8_MAX;  break;
+                    case homekit_format_uint16: lo=0;         hi=UINT16_MAX; break;
+                    case homekit_format_uint32: lo=0;         hi=UINT32_MAX; break;
+                    case homekit_format_int:    lo=INT32_MIN; hi=INT32_MAX;  break;
+                    case homekit_format_float:  lo=INT32_MIN; hi=INT32_MAX;  break; //in steps
+                    default: continue;
+                }
+                if (bounds_n==BOUNDS_N) {
+                    printf("%s: %s: no room, raise BOUNDS_N\n",__func__,ch->description);
+                    continue;
+                }
+                b=&bounds[bounds_n++];
+                b->ch=ch;
+                b->is_float=(ch->format==homekit_format_float);
+                b->scale=(b->is_float && ch->min_step && *ch->min_step>0)?(uint32_t)(1 / *ch->min_step + 0.5):1;
+                b->min=(ch->min_value && *ch->min_value*b->scale>lo)?(int64_t)(*ch->min_value*b->scale):lo;
+                b->max=(ch->max_value && *ch->max_value*b->scale<hi)?(int64_t)(*ch->max_value*b->scale):hi;
+                b->last=(b->is_float)?(int64_t)(ch->value.float_value*b->scale):(int64_t)ch->value.int_value;
+                printf("%s: %s: scale=%u, min=%.0f, max=%.0f\n",__func__,ch->description,b->scale,(double)b->min,(double)b->max);
             }
-            break;
-        case homekit_format_uint8:
-            printf ("Checking uint8 bounds");
-            if (ch->value.int_value > *ch->max_value){
-                printf (" Greater than max, setting to max");
-                ch->value.int_value = *ch->max_value;
-            }
-            if (ch->value.int_value < *ch->min_value){
-                printf (" Lower than min, setting to min");
-                ch->value.int_value = *ch->min_value;
-            }
-            break;
-        case homekit_format_int:
-        case homekit_format_uint16:
-        case homekit_format_uint32:
-            printf ("Checking integer bounds");
-            if (ch->value.int_value > *ch->max_value){
-                printf (" Greater than max, setting to max");
-                ch->value.int_value = *ch->max_value;
-            }
-            if (ch->value.int_value < *ch->min_value){
-                printf (" Lower than min, setting to min");
-                ch->value.int_value = *ch->min_value;
-            }
-            break;
-        case homekit_format_string:
-            break;
-        case homekit_format_float:
-            printf ("Checking float bounds");
-            if (ch->value.float_value > *ch->max_value){
-                printf (" Greater than max, setting to max");
-                ch->value.float_value = *ch->max_value;
-            }
-            if (ch->value.float_value < *ch->min_value){
-                printf (" Lower than min, setting to min");
-                ch->value.float_value = *ch->min_value;
-            }
-            break;
-        case homekit_format_uint64:
-        case homekit_format_tlv:
-        default:
-            printf ("Unknown characteristic format\n");
+        }
     }
-    printf("\n");
+}
+
+bounds_t *bounds_of(homekit_characteristic_t *ch) {
+    for (int i=0; i<bounds_n; i++) if (bounds[i].ch==ch) return &bounds[i];
+    printf("%s: %s: not a measurement\n",__func__,ch->description);
+    return NULL;
+}
+
+bool bounds_update(bounds_t *b, uint64_t value) { //returns true if the clamped value differs from the stored one
+    int64_t steps=(value>INT64_MAX)?INT64_MAX:(int64_t)value; //clamp before narrowing to the format
+    if (!b) return false;
+    if (steps>b->max) steps=b->max;
+    if (steps<b->min) steps=b->min;
+    if (steps==b->last) return false;
+    b->last=steps;
+    if (b->is_float) b->ch->value.float_value=steps/(float)b->scale; else b->ch->value.int_value=steps;
+    return true;
 }
 void relay_write(bool on, int gpio) {
     gpio_write(gpio, on ? 1 : 0);
@@ -155,6 +171,7 @@ float calibrated_current_multiplier=13118710;
 float calibrated_power_multiplier=1668220;
 float calibrated_energy_multiplier=0.460727;
 bool  cf0_done,cf1_done;
+uint32_t mains_period=20000; //microseconds, from sysparam mains_hz (50 or 60), minimum windows last whole mains periods
 
 
 void relay_callback(homekit_characteristic_t *_ch, homekit_value_t on, void *context) {
@@ -178,20 +195,20 @@ void save_characteristics() {
     save_float_param ( "wattsx", calibrated_power_multiplier);
     save_float_param ( "voltsx", calibrated_volts_multiplier);
     save_float_param ( "currentx", calibrated_current_multiplier);
+    budget_record(BUDGET_TIMER); //the sysparam flash writes are the deepest timer callback
 }
 
-void calibrate_task() {
+void calibrate_done(void *arg) { //runs in the timer task, so calibration costs no stack of its own
 //     HLW8012_set_calibrated_mutipliers (&calibrated_current_multiplier, &calibrated_volts_multiplier, &calibrated_power_multiplier, calibrate_volts.value.int_value, calibrate_power.value.int_value) ;
     
     sdk_os_timer_arm (&save_timer, SAVE_DELAY, 0 );
     
     calibrate_pow.value.bool_value = false;
     homekit_characteristic_notify(&calibrate_pow, calibrate_pow.value);
-
-    vTaskDelete (NULL);
+    budget_record(BUDGET_TIMER);
 }
 void calibrate_pow_set(homekit_value_t value) {
-    xTaskCreate(calibrate_task, "Calibrate task", 512, NULL, tskIDLE_PRIORITY+1, NULL);
+    sdk_os_timer_arm (&calibrate_timer, 10, 0 ); //notify after the write has been answered
 }
 
 void calibrate_volts_set(homekit_value_t value) {
@@ -215,26 +232,37 @@ void CF0_task(void *arg) {
     SemaphoreHandle_t mySemaphore=xSemaphoreCreateBinary();
     BL0937_data_t dataW;
     dataW.semaphore=mySemaphore;
-    dataW.mintime=1000*1000; //1 second
+    dataW.mintime= 200*1000; //200 msecond, ending on whole mains periods keeps such short windows accurate
+    dataW.period=mains_period;
     dataW.total=0;
+    dataW.burst=dataW.cycle=0;
+    dataW.steady=false;
     BaseType_t taken;
+    uint32_t pulses,span;
     float old_value=0;
+    TickType_t stored=xTaskGetTickCount();
     
     while (1) {
         BL0937_collect(SOURCE_CF,&dataW);
         cf0_done=false;
         while(!cf0_done) {
             taken=xSemaphoreTake(mySemaphore, 10000/portTICK_PERIOD_MS);
-            // process current results, be aware that the count could be as high as 2500 so first part just under 2^32
-            watts.value.float_value=(dataW.count>1)?((int)((1668220*(dataW.count-1))/((dataW.now-dataW.time[0])/10)))/10.0:0;
-            homekit_characteristic_bounds_check(&watts);
-            homekit_characteristic_notify(&watts,watts.value);
-            mWhs.value.int_value=(uint32_t)(dataW.total*0.460727);
-            homekit_characteristic_bounds_check(&mWhs);
-            homekit_characteristic_notify(&mWhs,mWhs.value);
+            // process current results, a window spanning whole bursts can hold far more than 2500 pulses so use 64 bits
+            pulses=BL0937_window(&dataW,&span);
+            if (bounds_update(watts_bounds,span?(uint64_t)16682200*pulses/span:0)) //deciWatts
+                homekit_characteristic_notify(&watts,watts.value);
+            if (xTaskGetTickCount()-stored>=1000/portTICK_PERIOD_MS) { //energy keeps its once a second pace, windows are shorter
+                stored=xTaskGetTickCount();
+                if (bounds_update(mWhs_bounds,(uint64_t)(dataW.total*0.460727)))
+                    homekit_characteristic_notify(&mWhs,mWhs.value);
+            }
+            metrics.watts=watts.value.float_value;
+            metrics.mwh=mWhs.value.int_value;
+            metrics.cf_pulses=dataW.total;
+            budget_record(BUDGET_CF0);
             if (taken) printf("CF   taken:   "); else printf("CF   timeout: ");
             printf("c=%d, n=%u, t0=%u, t1=%u, t2=%u, t3=%u, t4=%u, t=%u",dataW.count,dataW.now,dataW.time[0],dataW.time[1],dataW.time[2],dataW.time[3],dataW.time[4],dataW.total);
-            printf(", avg=%u us, %.1fW, %umWh\n",(dataW.count>1)?(dataW.now-dataW.time[0])/(dataW.count-1):0,watts.value.float_value,mWhs.value.int_value);
+            printf(", b=%u, avg=%u us, %.1fW, %umWh\n",dataW.bursts,pulses?span/pulses:0,watts.value.float_value,mWhs.value.int_value);
             // prepare future results
             cf0_done=(cf0_done || 20*watts.value.float_value<old_value || BL0937_process(&dataW,taken));
             if (20*watts.value.float_value<old_value) cf1_done=true; //when connected device switches off, detect ASAP
@@ -252,33 +280,51 @@ void CF1_task(void *arg) {
     dataV.semaphore=mySemaphore;
     dataA.semaphore=mySemaphore;
     dataV.mintime=  50*1000; //50 msecond
-    dataA.mintime=1000*1000; // 1  second
+    dataA.mintime= 200*1000; //200 msecond
+    dataV.period=mains_period; //at least 50ms becomes 3 whole periods
+    dataA.period=mains_period;
+    dataV.total=0;
+    dataA.total=0;
+    dataV.burst=dataV.cycle=0;
+    dataA.burst=dataA.cycle=0;
+    dataV.steady=dataA.steady=false;
     BaseType_t taken;
     uint16_t old_value=0;
+    uint32_t pulses,span;
+    TickType_t reported=xTaskGetTickCount();
     
     while (1) {
         BL0937_collect(SOURCE_CF1V,&dataV);
         taken=xSemaphoreTake(mySemaphore, 100/portTICK_PERIOD_MS);
         // process current results
-        volts.value.int_value=(dataV.count>1)?(int)142000*(dataV.count-1)/(dataV.now-dataV.time[0]):0;
-        homekit_characteristic_bounds_check(&volts);
-        homekit_characteristic_notify(&volts,volts.value);
+        pulses=BL0937_window(&dataV,&span);
+        if (bounds_update(volts_bounds,span?(uint64_t)142000*pulses/span:0))
+            homekit_characteristic_notify(&volts,volts.value);
+        metrics.volts=volts.value.int_value;
+        metrics.cf1v_pulses=dataV.total;
         if (taken) printf("CF1V taken:   "); else printf("CF1V timeout: ");
         printf("c=%d, n=%u, t0=%u",dataV.count,dataV.now,dataV.time[0]);
-        printf(", avg=%u us, %uV\n",(dataV.count>1)?(dataV.now-dataV.time[0])/(dataV.count-1):0,volts.value.int_value);
+        printf(", avg=%u us, %uV\n",pulses?span/pulses:0,volts.value.int_value);
         // no point in slow shifting, move on to Current(mAmps)
         
         BL0937_collect(SOURCE_CF1A,&dataA);
         cf1_done=false;
         while(!cf1_done) {
             taken=xSemaphoreTake(mySemaphore, 10000/portTICK_PERIOD_MS);
-            // process current results, be aware that the count could be as high as 3000 so first part just under 2^32
-            mamps.value.int_value=(dataA.count>1)?(int)(((13118710/10)*(dataA.count-1)/((dataA.now-dataA.time[0])/10))+0.5):0;
-            homekit_characteristic_bounds_check(&mamps);
-            homekit_characteristic_notify(&mamps,mamps.value);
+            // process current results, a window spanning whole bursts can hold far more than 3000 pulses so use 64 bits
+            pulses=BL0937_window(&dataA,&span);
+            if (bounds_update(mamps_bounds,span?(uint64_t)13118710*pulses/span:0))
+                homekit_characteristic_notify(&mamps,mamps.value);
+            metrics.mamps=mamps.value.int_value;
+            metrics.cf1a_pulses=dataA.total;
+            budget_record(BUDGET_CF1);
+            if (xTaskGetTickCount()-reported>=BUDGET_REPORT_INTERVAL/portTICK_PERIOD_MS) {
+                reported=xTaskGetTickCount();
+                budget_report();
+            }
             if (taken) printf("CF1A taken:   "); else printf("CF1A timeout: ");
             printf("c=%d, n=%u, t0=%u, t1=%u, t2=%u, t3=%u, t4=%u",dataA.count,dataA.now,dataA.time[0],dataA.time[1],dataA.time[2],dataA.time[3],dataA.time[4]);
-            printf(", avg=%u us, %umA\n",(dataA.count>1)?(dataA.now-dataA.time[0])/(dataA.count-1):0,mamps.value.int_value);
+            printf(", b=%u, avg=%u us, %umA\n",dataA.bursts,pulses?span/pulses:0,mamps.value.int_value);
             // prepare future results
             cf1_done=(cf1_done || 20*mamps.value.int_value<old_value || BL0937_process(&dataA,taken));
             if (20*mamps.value.int_value<old_value) cf0_done=true; //when connected device switches off, detect ASAP
@@ -360,6 +406,9 @@ void device_init() {
     load_float_param ( "wattsx", &calibrated_power_multiplier);
     load_float_param ( "voltsx", &calibrated_volts_multiplier);
     load_float_param ( "currentx", &calibrated_current_multiplier);
+    int32_t mains_hz;
+    if (sysparam_get_int32("mains_hz", &mains_hz) == SYSPARAM_OK && mains_hz>=40 && mains_hz<=70) mains_period=1000000/mains_hz;
+    printf ("%s:mains period %u us\n", __func__, mains_period);
     
     if (calibrated_power_multiplier !=0 && calibrated_current_multiplier !=0 && calibrated_volts_multiplier !=0) {
         printf ("%s:Setting calibrated multipliers, current: %f, voltage: %f, watts: %f\n", __func__, calibrated_current_multiplier, calibrated_volts_multiplier, calibrated_power_multiplier);
@@ -370,10 +419,17 @@ void device_init() {
         printf ("%s:calibrated mutipliers not available, current: %f, voltage: %f, watts: %f\n", __func__, calibrated_current_multiplier, calibrated_volts_multiplier, calibrated_power_multiplier);
     }
     
+    bounds_resolve();
+    watts_bounds=bounds_of(&watts);
+    volts_bounds=bounds_of(&volts);
+    mamps_bounds=bounds_of(&mamps);
+    mWhs_bounds =bounds_of(&mWhs);
     BL0937_init(CF_GPIO, CF1_GPIO, SELi_GPIO, MODEL_BL0937);
-    xTaskCreate(CF0_task, "CF0_Task", 512, NULL, tskIDLE_PRIORITY+1, NULL);
-    xTaskCreate(CF1_task, "CF1_task", 512, NULL, tskIDLE_PRIORITY+1, NULL);
+    xTaskCreate(CF0_task, "CF0_Task", CF0_STACK, NULL, tskIDLE_PRIORITY+1, NULL);
+    xTaskCreate(CF1_task, "CF1_task", CF1_STACK, NULL, tskIDLE_PRIORITY+1, NULL);
+    metrics_init();
     sdk_os_timer_setfn(&save_timer, save_characteristics, NULL);
+    sdk_os_timer_setfn(&calibrate_timer, calibrate_done, NULL);
 
     // homekit_characteristic_notify(&relay, relay.value);
   }
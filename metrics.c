@@ -0,0 +1,124 @@
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+#include <FreeRTOS.h>
+#include <task.h>
+#include <lwip/sockets.h>
+#include <http-parser/http_parser.h>
+#include <BL0937.h>
+#include <budget.h>
+#include <metrics.h>
+
+metrics_snapshot_t metrics;
+
+static char _url[9]; //enough to tell "/metrics" from any longer path
+static size_t _url_len;
+static bool _is_metrics;
+static bool _complete;
+
+static int _on_url(http_parser *parser, const char *at, size_t length) { //a url split over two reads comes in two calls
+    for (size_t i=0; i<length; i++, _url_len++) if (_url_len<sizeof(_url)) _url[_url_len]=at[i];
+    return 0;
+}
+
+static int _on_headers_complete(http_parser *parser) {
+    _is_metrics=(parser->method==HTTP_GET && _url_len>=8 && !strncmp(_url,"/metrics",8) && (_url_len==8 || _url[8]=='?'));
+    return 0;
+}
+
+static int _on_message_complete(http_parser *parser) {
+    _complete=true;
+    return 0;
+}
+
+static const http_parser_settings _settings = {
+    .on_url = _on_url,
+    .on_headers_complete = _on_headers_complete,
+    .on_message_complete = _on_message_complete,
+};
+
+static void _print(int client, const char *format, ...) { //one line at a time from the stack, the response needs no buffer
+    char line[100];
+    va_list args;
+    int len;
+    va_start(args, format);
+    len=vsnprintf(line, sizeof(line), format, args);
+    va_end(args);
+    if (len>=(int)sizeof(line)) len=sizeof(line)-1;
+    if (len>0) write(client, line, len);
+}
+
+static void _metrics(int client) {
+    metrics_snapshot_t snap;
+    taskENTER_CRITICAL(); //only a struct copy, the tasks never wait for us
+    snap=metrics;
+    taskEXIT_CRITICAL();
+
+    //no Content-Length, the body ends when we close the connection
+    _print(client, "HTTP/1.1 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\nConnection: close\r\n\r\n");
+    _print(client, "# TYPE nas_power_watts gauge\nnas_power_watts %.1f\n", snap.watts);
+    _print(client, "# TYPE nas_voltage_volts gauge\nnas_voltage_volts %u\n", snap.volts);
+    _print(client, "# TYPE nas_current_milliamps gauge\nnas_current_milliamps %u\n", snap.mamps);
+    _print(client, "# TYPE nas_energy_mwh_total counter\nnas_energy_mwh_total %u\n", snap.mwh);
+    _print(client, "# TYPE nas_pulses_total counter\n");
+    _print(client, "nas_pulses_total{channel=\"cf\"} %u\n", snap.cf_pulses);
+    _print(client, "nas_pulses_total{channel=\"cf1v\"} %u\n", snap.cf1v_pulses);
+    _print(client, "nas_pulses_total{channel=\"cf1a\"} %u\n", snap.cf1a_pulses);
+    _print(client, "# TYPE nas_rejected_pulses_total counter\n");
+    _print(client, "nas_rejected_pulses_total{pin=\"cf\"} %u\n", BL0937_rejected(SOURCE_CF));
+    _print(client, "nas_rejected_pulses_total{pin=\"cf1\"} %u\n", BL0937_rejected(SOURCE_CF1A));
+    _print(client, "# TYPE nas_heap_free_bytes gauge\nnas_heap_free_bytes %u\n", (uint32_t)xPortGetFreeHeapSize());
+    if (budget_heap_min()) _print(client, "# TYPE nas_heap_min_free_bytes gauge\nnas_heap_min_free_bytes %u\n", budget_heap_min());
+    _print(client, "# TYPE nas_uptime_seconds counter\nnas_uptime_seconds %u\n", (uint32_t)(xTaskGetTickCount()/configTICK_RATE_HZ));
+    _print(client, "# TYPE nas_stack_free_words gauge\n");
+    for (int i=0; i<BUDGET_N; i++) {
+        if (budget[i].stack_free) _print(client, "nas_stack_free_words{task=\"%s\",size=\"%u\"} %u\n",
+                                         budget[i].name, budget[i].stack, budget[i].stack_free);
+    }
+}
+
+static void _serve(int client) {
+    http_parser parser;
+    char request[64];
+    int len;
+
+    http_parser_init(&parser, HTTP_REQUEST);
+    _url_len=0;
+    _is_metrics=_complete=false;
+    while (!_complete) {
+        len=read(client, request, sizeof(request));
+        if (len<=0) return; //closed or timed out
+        if (http_parser_execute(&parser, &_settings, request, len)!=(size_t)len) return;
+    }
+    if (_is_metrics) _metrics(client);
+    else _print(client, "HTTP/1.1 404 Not Found\r\nContent-Length: 0\r\nConnection: close\r\n\r\n");
+}
+
+static void metrics_task(void *arg) {
+    struct sockaddr_in addr;
+    struct timeval timeout = {.tv_sec=2, .tv_usec=0};
+    int server, client;
+
+    server=socket(AF_INET, SOCK_STREAM, 0);
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family=AF_INET;
+    addr.sin_addr.s_addr=htonl(INADDR_ANY);
+    addr.sin_port=htons(METRICS_PORT);
+    if (server<0 || bind(server, (struct sockaddr*)&addr, sizeof(addr))<0 || listen(server, 2)<0) {
+        printf("%s: cannot listen on port %d\n", __func__, METRICS_PORT);
+        if (server>=0) close(server);
+        vTaskDelete(NULL);
+    }
+    while (1) { //one scrape at a time, a slow client only ever stalls this task
+        client=accept(server, NULL, NULL);
+        if (client<0) continue;
+        setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        _serve(client);
+        close(client);
+        budget_record(BUDGET_METRICS);
+    }
+}
+
+void metrics_init(void) {
+    if (METRICS_PORT) xTaskCreate(metrics_task, "metrics_task", METRICS_STACK, NULL, tskIDLE_PRIORITY+1, NULL);
+}
@@ -0,0 +1,25 @@
+#ifndef metrics_h
+#define metrics_h
+
+#include <stdint.h>
+
+#ifndef METRICS_PORT
+#define METRICS_PORT 80 //0 leaves the server out and saves its METRICS_STACK
+#endif
+
+// plain word sized fields only, so the measurement tasks can store them without any locking
+typedef struct {
+    float               watts;
+    uint32_t            volts;
+    uint32_t            mamps;
+    uint32_t            mwh;
+    uint32_t            cf_pulses;      //totals since boot
+    uint32_t            cf1v_pulses;
+    uint32_t            cf1a_pulses;
+} metrics_snapshot_t;
+
+extern metrics_snapshot_t metrics; //written by the measurement tasks, copied by the http server
+
+void metrics_init(void);
+
+#endif
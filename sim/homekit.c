@@ -0,0 +1,92 @@
+#include <stdlib.h>
+#include <string.h>
+#include "sim.h"
+
+#ifndef HOMEKIT_MAX_CLIENTS
+#define HOMEKIT_MAX_CLIENTS 16
+#endif
+
+sim_event_t *sim_events=NULL;
+uint32_t     sim_event_count=0;
+int          sim_clients=HOMEKIT_MAX_CLIENTS; //all paired and subscribed to every notifying characteristic
+
+static uint32_t _capacity=0;
+static int      _items=0;   //length of the characteristics in the EVENT message being built
+static uint32_t _cost=0;    //its bytes on the wire so far
+
+static uint32_t _framed(int items) { //whole EVENT message around items
+    char header[128];
+    int len=items+strlen("{\"characteristics\":[]}"), frames;
+    len+=snprintf(header, sizeof(header), "EVENT/1.0 200 OK\r\nContent-Type: application/hap+json\r\nContent-Length: %d\r\n\r\n", len);
+    frames=(len+1023)/1024; //HAP session: 2 byte length and 16 byte tag per frame of at most 1024 bytes
+    return len+frames*(2+16);
+}
+
+void homekit_server_init(homekit_server_config_t *config) { //assign instance ids the way esp-homekit does
+    for (homekit_accessory_t **accessory=config->accessories; *accessory; accessory++) {
+        unsigned int iid=1;
+        for (homekit_service_t **service=(*accessory)->services; *service; service++) {
+            (*service)->accessory=*accessory;
+            (*service)->id=iid++;
+            for (homekit_characteristic_t **ch=(*service)->characteristics; *ch; ch++) {
+                (*ch)->service=*service;
+                (*ch)->id=iid++;
+            }
+        }
+    }
+}
+
+bool homekit_is_paired(void) {
+    return true;
+}
+
+static int _json_value(char *buf, int size, homekit_value_t value) { //formatted like esp-homekit's json writer
+    switch (value.format) {
+        case homekit_format_bool:
+            return snprintf(buf, size, "%s", value.bool_value?"true":"false");
+        case homekit_format_float:
+            return snprintf(buf, size, "%1.15g", value.float_value);
+        case homekit_format_string:
+            return snprintf(buf, size, "\"%s\"", value.string_value);
+        case homekit_format_uint32:
+            return snprintf(buf, size, "%u", (uint32_t)value.int_value);
+        default:
+            return snprintf(buf, size, "%d", value.int_value);
+    }
+}
+
+// esp-homekit queues events per client and sends what is queued as one EVENT message,
+// so notifications at the same virtual instant (like WATTS and mWh from CF0_task) share a message
+void homekit_characteristic_notify(homekit_characteristic_t *ch, const homekit_value_t value) {
+    char item[96], json[48];
+    int len;
+    bool message;
+    uint32_t cost;
+
+    for (homekit_characteristic_change_callback_t *cb=ch->callback; cb; cb=cb->next) cb->function(ch, value, cb->context);
+    if (!(ch->permissions&homekit_permissions_notify)) return;
+
+    _json_value(json, sizeof(json), value);
+    len=snprintf(item, sizeof(item), "{\"aid\":%u,\"iid\":%u,\"value\":%s}",
+                 ch->service?ch->service->accessory->id:0, ch->id, json);
+    message=!sim_event_count || sim_events[sim_event_count-1].time!=sim_now();
+    if (message) {
+        _items=0;
+        _cost=0;
+    }
+    _items+=len+(_items?1:0); //comma separated
+    cost=_framed(_items);
+
+    if (sim_event_count==_capacity) {
+        _capacity=_capacity?2*_capacity:1024;
+        sim_events=realloc(sim_events, _capacity*sizeof(sim_event_t));
+    }
+    sim_events[sim_event_count++]=(sim_event_t){
+        .time=sim_now(),
+        .ch=ch,
+        .value=value,
+        .bytes=cost-_cost,
+        .message=message,
+    };
+    _cost=cost;
+}
@@ -0,0 +1,31 @@
+// host stand-in for the esp-open-rtos FreeRTOS port, see sim/rtos.c
+#ifndef FREERTOS_H
+#define FREERTOS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+typedef long            BaseType_t;
+typedef unsigned long   UBaseType_t;
+typedef uint32_t        TickType_t;
+typedef struct sim_task *TaskHandle_t;
+typedef struct sim_sem  *SemaphoreHandle_t;
+
+#define configTICK_RATE_HZ  100
+#define configTIMER_TASK_STACK_DEPTH 512
+#define portTICK_PERIOD_MS  (1000/configTICK_RATE_HZ)
+#define portMAX_DELAY       UINT32_MAX
+#define tskIDLE_PRIORITY    0
+#define pdTRUE              1
+#define pdFALSE             0
+#define pdPASS              pdTRUE
+
+// only one simulated task runs at a time and interrupts are delivered between them
+#define taskENTER_CRITICAL()
+#define taskEXIT_CRITICAL()
+#define taskYIELD()
+
+size_t xPortGetFreeHeapSize(void);
+
+#endif
@@ -0,0 +1,13 @@
+#ifndef ADV_BUTTON_H
+#define ADV_BUTTON_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef void (*button_callback_fn)(uint8_t gpio, void *args);
+
+static inline void adv_button_set_evaluate_delay(uint8_t delay) {}
+static inline int  adv_button_create(uint8_t gpio, bool pullup, bool inverted) {return 0;}
+static inline int  adv_button_register_callback_fn(uint8_t gpio, button_callback_fn callback, uint8_t type, void *args) {return 0;}
+
+#endif
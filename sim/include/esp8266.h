@@ -0,0 +1,29 @@
+#ifndef ESP8266_H
+#define ESP8266_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define IRAM
+
+typedef enum {
+    GPIO_INPUT,
+    GPIO_OUTPUT,
+    GPIO_OUT_OPEN_DRAIN,
+} gpio_direction_t;
+
+typedef enum {
+    GPIO_INTTYPE_NONE = 0,
+    GPIO_INTTYPE_EDGE_POS,
+    GPIO_INTTYPE_EDGE_NEG,
+    GPIO_INTTYPE_EDGE_ANY,
+} gpio_inttype_t;
+
+typedef void (*gpio_interrupt_handler_t)(uint8_t gpio_num);
+
+void gpio_enable(uint8_t gpio_num, gpio_direction_t direction);
+void gpio_set_pullup(uint8_t gpio_num, bool enabled, bool enabled_during_sleep);
+void gpio_write(uint8_t gpio_num, bool set);
+void gpio_set_interrupt(uint8_t gpio_num, gpio_inttype_t int_type, gpio_interrupt_handler_t handler);
+
+#endif
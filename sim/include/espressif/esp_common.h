@@ -0,0 +1,10 @@
+#ifndef ESP_COMMON_H
+#define ESP_COMMON_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+uint32_t sdk_system_get_time(void);
+void     sdk_os_delay_us(uint16_t us);
+
+#endif
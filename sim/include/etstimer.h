@@ -0,0 +1,21 @@
+#ifndef ETSTIMER_H
+#define ETSTIMER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef void ETSTimerFunc(void *arg);
+
+typedef struct ETSTimer_st {
+    ETSTimerFunc        *timer_func;
+    void                *timer_arg;
+    uint64_t            expire;     //virtual microseconds, 0 = disarmed
+    uint32_t            period;     //milliseconds, 0 = one-shot
+    struct ETSTimer_st  *next;
+} ETSTimer;
+
+void sdk_os_timer_setfn(ETSTimer *ptimer, ETSTimerFunc *pfunction, void *parg);
+void sdk_os_timer_arm(ETSTimer *ptimer, uint32_t milliseconds, bool repeat_flag);
+void sdk_os_timer_disarm(ETSTimer *ptimer);
+
+#endif
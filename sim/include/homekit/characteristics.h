@@ -0,0 +1,75 @@
+// the Apple services and characteristics used by main.c, with short uuids as in HOMEKIT_SHORT_APPLE_UUIDS
+#ifndef HOMEKIT_CHARACTERISTICS_H
+#define HOMEKIT_CHARACTERISTICS_H
+
+#include <homekit/types.h>
+
+#define HOMEKIT_SERVICE_ACCESSORY_INFORMATION "3E"
+#define HOMEKIT_SERVICE_SWITCH "49"
+
+#define HOMEKIT_CHARACTERISTIC_NAME "23"
+#define HOMEKIT_DECLARE_CHARACTERISTIC_NAME(_value, ...) \
+    .type = HOMEKIT_CHARACTERISTIC_NAME, \
+    .description = "Name", \
+    .format = homekit_format_string, \
+    .permissions = homekit_permissions_paired_read, \
+    .value = HOMEKIT_STRING_(_value), \
+    ##__VA_ARGS__
+
+#define HOMEKIT_CHARACTERISTIC_MANUFACTURER "20"
+#define HOMEKIT_DECLARE_CHARACTERISTIC_MANUFACTURER(_value, ...) \
+    .type = HOMEKIT_CHARACTERISTIC_MANUFACTURER, \
+    .description = "Manufacturer", \
+    .format = homekit_format_string, \
+    .permissions = homekit_permissions_paired_read, \
+    .value = HOMEKIT_STRING_(_value), \
+    ##__VA_ARGS__
+
+#define HOMEKIT_CHARACTERISTIC_SERIAL_NUMBER "30"
+#define HOMEKIT_DECLARE_CHARACTERISTIC_SERIAL_NUMBER(_value, ...) \
+    .type = HOMEKIT_CHARACTERISTIC_SERIAL_NUMBER, \
+    .description = "Serial Number", \
+    .format = homekit_format_string, \
+    .permissions = homekit_permissions_paired_read, \
+    .value = HOMEKIT_STRING_(_value), \
+    ##__VA_ARGS__
+
+#define HOMEKIT_CHARACTERISTIC_MODEL "21"
+#define HOMEKIT_DECLARE_CHARACTERISTIC_MODEL(_value, ...) \
+    .type = HOMEKIT_CHARACTERISTIC_MODEL, \
+    .description = "Model", \
+    .format = homekit_format_string, \
+    .permissions = homekit_permissions_paired_read, \
+    .value = HOMEKIT_STRING_(_value), \
+    ##__VA_ARGS__
+
+#define HOMEKIT_CHARACTERISTIC_FIRMWARE_REVISION "52"
+#define HOMEKIT_DECLARE_CHARACTERISTIC_FIRMWARE_REVISION(_value, ...) \
+    .type = HOMEKIT_CHARACTERISTIC_FIRMWARE_REVISION, \
+    .description = "Firmware Revision", \
+    .format = homekit_format_string, \
+    .permissions = homekit_permissions_paired_read, \
+    .value = HOMEKIT_STRING_(_value), \
+    ##__VA_ARGS__
+
+#define HOMEKIT_CHARACTERISTIC_IDENTIFY "14"
+#define HOMEKIT_DECLARE_CHARACTERISTIC_IDENTIFY(_value, ...) \
+    .type = HOMEKIT_CHARACTERISTIC_IDENTIFY, \
+    .description = "Identify", \
+    .format = homekit_format_bool, \
+    .permissions = homekit_permissions_paired_write, \
+    .setter = _value, \
+    ##__VA_ARGS__
+
+#define HOMEKIT_CHARACTERISTIC_ON "25"
+#define HOMEKIT_DECLARE_CHARACTERISTIC_ON(_value, ...) \
+    .type = HOMEKIT_CHARACTERISTIC_ON, \
+    .description = "On", \
+    .format = homekit_format_bool, \
+    .permissions = homekit_permissions_paired_read \
+                 | homekit_permissions_paired_write \
+                 | homekit_permissions_notify, \
+    .value = HOMEKIT_BOOL_(_value), \
+    ##__VA_ARGS__
+
+#endif
@@ -0,0 +1,19 @@
+// host stand-in for the esp-homekit server, see sim/homekit.c
+#ifndef HOMEKIT_H
+#define HOMEKIT_H
+
+#include <homekit/types.h>
+
+typedef struct {
+    homekit_accessory_t **accessories;
+    homekit_accessory_category_t category;
+    int                 config_number;
+    char                *password;
+    void                (*on_event)(int event);
+} homekit_server_config_t;
+
+void homekit_server_init(homekit_server_config_t *config);
+bool homekit_is_paired(void);
+void homekit_characteristic_notify(homekit_characteristic_t *ch, const homekit_value_t value);
+
+#endif
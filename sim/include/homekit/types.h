@@ -0,0 +1,110 @@
+// subset of the esp-homekit accessory model, enough to build main.c's accessories[] on the host
+#ifndef HOMEKIT_TYPES_H
+#define HOMEKIT_TYPES_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef enum {
+    homekit_format_bool,
+    homekit_format_uint8,
+    homekit_format_uint16,
+    homekit_format_uint32,
+    homekit_format_uint64,
+    homekit_format_int,
+    homekit_format_float,
+    homekit_format_string,
+    homekit_format_tlv,
+    homekit_format_data,
+} homekit_format_t;
+
+typedef enum {
+    homekit_permissions_paired_read   = 1,
+    homekit_permissions_paired_write  = 2,
+    homekit_permissions_notify        = 4,
+    homekit_permissions_hidden        = 64,
+} homekit_permissions_t;
+
+typedef enum {
+    homekit_accessory_category_other  = 1,
+    homekit_accessory_category_outlet = 7,
+    homekit_accessory_category_switch = 8,
+} homekit_accessory_category_t;
+
+typedef struct {
+    bool                is_null;
+    homekit_format_t    format;
+    union {
+        bool            bool_value;
+        int             int_value;
+        float           float_value;
+        char            *string_value;
+    };
+} homekit_value_t;
+
+typedef struct _homekit_accessory homekit_accessory_t;
+typedef struct _homekit_service homekit_service_t;
+typedef struct _homekit_characteristic homekit_characteristic_t;
+
+typedef void (*homekit_characteristic_change_callback_fn)(homekit_characteristic_t *ch, homekit_value_t value, void *context);
+
+typedef struct _homekit_characteristic_change_callback {
+    homekit_characteristic_change_callback_fn function;
+    void                *context;
+    struct _homekit_characteristic_change_callback *next;
+} homekit_characteristic_change_callback_t;
+
+struct _homekit_characteristic {
+    homekit_service_t   *service;
+    unsigned int        id;
+    const char          *type;
+    const char          *description;
+    homekit_format_t    format;
+    homekit_permissions_t permissions;
+    homekit_value_t     value;
+    float               *min_value;
+    float               *max_value;
+    float               *min_step;
+    homekit_characteristic_change_callback_t *callback;
+    homekit_value_t     (*getter)(void);
+    void                (*setter)(const homekit_value_t);
+};
+
+struct _homekit_service {
+    homekit_accessory_t *accessory;
+    unsigned int        id;
+    const char          *type;
+    bool                primary;
+    homekit_characteristic_t **characteristics;
+};
+
+struct _homekit_accessory {
+    unsigned int        id;
+    homekit_accessory_category_t category;
+    int                 config_number;
+    homekit_service_t   **services;
+};
+
+#define HOMEKIT_BOOL_(value, ...)   {.format=homekit_format_bool,   .bool_value=(value),   ##__VA_ARGS__}
+#define HOMEKIT_INT_(value, ...)    {.format=homekit_format_int,    .int_value=(value),    ##__VA_ARGS__}
+#define HOMEKIT_UINT8_(value, ...)  {.format=homekit_format_uint8,  .int_value=(value),    ##__VA_ARGS__}
+#define HOMEKIT_UINT16_(value, ...) {.format=homekit_format_uint16, .int_value=(value),    ##__VA_ARGS__}
+#define HOMEKIT_UINT32_(value, ...) {.format=homekit_format_uint32, .int_value=(value),    ##__VA_ARGS__}
+#define HOMEKIT_FLOAT_(value, ...)  {.format=homekit_format_float,  .float_value=(value),  ##__VA_ARGS__}
+#define HOMEKIT_STRING_(value, ...) {.format=homekit_format_string, .string_value=(value), ##__VA_ARGS__}
+
+#define HOMEKIT_BOOL(value, ...)    ((homekit_value_t) HOMEKIT_BOOL_(value, ##__VA_ARGS__))
+#define HOMEKIT_FLOAT(value, ...)   ((homekit_value_t) HOMEKIT_FLOAT_(value, ##__VA_ARGS__))
+
+#define HOMEKIT_ACCESSORY(...) \
+    &(homekit_accessory_t) { .config_number=1, .category=homekit_accessory_category_other, ##__VA_ARGS__ }
+#define HOMEKIT_SERVICE(_type, ...) \
+    &(homekit_service_t) { .type=HOMEKIT_SERVICE_ ## _type, ##__VA_ARGS__ }
+#define HOMEKIT_CHARACTERISTIC(name, ...) \
+    &(homekit_characteristic_t) { HOMEKIT_DECLARE_CHARACTERISTIC_ ## name(__VA_ARGS__) }
+#define HOMEKIT_CHARACTERISTIC_(name, ...) \
+    { HOMEKIT_DECLARE_CHARACTERISTIC_ ## name(__VA_ARGS__) }
+#define HOMEKIT_CHARACTERISTIC_CALLBACK(f, ...) \
+    &(homekit_characteristic_change_callback_t) { .function=f, ##__VA_ARGS__ }
+
+#endif
@@ -0,0 +1,59 @@
+// the part of the http-parser 2.x api (extras/http-parser) used by metrics.c, same names and signatures
+#ifndef http_parser_h
+#define http_parser_h
+
+#include <stddef.h>
+#include <stdint.h>
+
+enum http_method {
+    HTTP_DELETE = 0,
+    HTTP_GET,
+    HTTP_HEAD,
+    HTTP_POST,
+    HTTP_PUT,
+};
+
+enum http_parser_type { HTTP_REQUEST, HTTP_RESPONSE, HTTP_BOTH };
+
+typedef struct http_parser http_parser;
+typedef struct http_parser_settings http_parser_settings;
+
+typedef int (*http_data_cb)(http_parser *, const char *at, size_t length);
+typedef int (*http_cb)(http_parser *);
+
+struct http_parser {
+    unsigned int type : 2;
+    unsigned int flags : 8;
+    unsigned int state : 7;
+    unsigned int header_state : 7;
+    unsigned int index : 7;
+    unsigned int lenient_http_headers : 1;
+    uint32_t nread;
+    uint64_t content_length;
+    unsigned short http_major;
+    unsigned short http_minor;
+    unsigned int status_code : 16;
+    unsigned int method : 8;
+    unsigned int http_errno : 7;
+    unsigned int upgrade : 1;
+    void *data;
+};
+
+struct http_parser_settings {
+    http_cb      on_message_begin;
+    http_data_cb on_url;
+    http_data_cb on_status;
+    http_data_cb on_header_field;
+    http_data_cb on_header_value;
+    http_cb      on_headers_complete;
+    http_data_cb on_body;
+    http_cb      on_message_complete;
+    http_cb      on_chunk_header;
+    http_cb      on_chunk_complete;
+};
+
+void http_parser_init(http_parser *parser, enum http_parser_type type);
+
+size_t http_parser_execute(http_parser *parser, const http_parser_settings *settings, const char *data, size_t len);
+
+#endif
@@ -0,0 +1,11 @@
+// lwip's BSD socket layer maps onto the host sockets, only used to compile check metrics.c
+#ifndef LWIP_SOCKETS_H
+#define LWIP_SOCKETS_H
+
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+
+#endif
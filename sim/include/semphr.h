@@ -0,0 +1,11 @@
+#ifndef SEMPHR_H
+#define SEMPHR_H
+
+#include <FreeRTOS.h>
+
+SemaphoreHandle_t xSemaphoreCreateBinary(void);
+BaseType_t  xSemaphoreTake(SemaphoreHandle_t sem, TickType_t ticks);
+BaseType_t  xSemaphoreGive(SemaphoreHandle_t sem);
+BaseType_t  xSemaphoreGiveFromISR(SemaphoreHandle_t sem, BaseType_t *yield);
+
+#endif
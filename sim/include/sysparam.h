@@ -0,0 +1,14 @@
+#ifndef SYSPARAM_H
+#define SYSPARAM_H
+
+#include <stdint.h>
+
+typedef enum {
+    SYSPARAM_OK       = 0,
+    SYSPARAM_NOTFOUND = -1,
+} sysparam_status_t;
+
+sysparam_status_t sysparam_get_int32(const char *key, int32_t *result);
+sysparam_status_t sysparam_set_int32(const char *key, int32_t value);
+
+#endif
@@ -0,0 +1,12 @@
+#ifndef TASK_H
+#define TASK_H
+
+#include <FreeRTOS.h>
+
+BaseType_t  xTaskCreate(void (*fn)(void *), const char *name, uint16_t stack, void *arg, UBaseType_t prio, TaskHandle_t *handle);
+void        vTaskDelete(TaskHandle_t task);
+void        vTaskDelay(TickType_t ticks);
+TickType_t  xTaskGetTickCount(void);
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t task);
+
+#endif
@@ -0,0 +1,10 @@
+#ifndef UDPLOGGER_H
+#define UDPLOGGER_H
+
+#include <stdio.h>
+
+#define UDPLUS(format, ...) printf(format, ##__VA_ARGS__)
+
+static inline void udplog_init(int prio) {}
+
+#endif
@@ -0,0 +1,273 @@
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <FreeRTOS.h>
+#include <task.h>
+#include <semphr.h>
+#include <espressif/esp_common.h>
+#include <etstimer.h>
+#include <sysparam.h>
+#include "sim.h"
+
+typedef enum {
+    TASK_READY,
+    TASK_RUNNING,
+    TASK_BLOCKED,
+    TASK_DELETED,
+} task_state_t;
+
+struct sim_sem {
+    int                 count;
+};
+
+struct sim_task {
+    pthread_t           thread;
+    pthread_cond_t      cond;
+    void                (*fn)(void *);
+    void                *arg;
+    const char          *name;
+    uint16_t            stack;
+    task_state_t        state;
+    uint64_t            wake;       //UINT64_MAX = no timeout
+    struct sim_sem      *sem;       //waiting for this one, or NULL
+    BaseType_t          result;
+    struct sim_task     *next;
+};
+
+static pthread_mutex_t  _lock=PTHREAD_MUTEX_INITIALIZER; //held by whoever runs: one task or the scheduler
+static pthread_cond_t   _sched=PTHREAD_COND_INITIALIZER;
+static struct sim_task  *_tasks=NULL;
+static struct sim_task  *_current=NULL;
+static uint64_t         _now=0;
+static ETSTimer         *_timers=NULL;
+
+static gpio_interrupt_handler_t _handler[SIM_GPIO_N];
+static bool             _level[SIM_GPIO_N];
+
+static struct {
+    const char          *key;
+    int32_t             value;
+} _sysparam[8];
+
+uint64_t sim_now(void) {
+    return _now;
+}
+
+/* ---- tasks ---- */
+
+static void *_task_main(void *arg) {
+    struct sim_task *task=arg;
+    pthread_mutex_lock(&_lock);
+    while (task->state!=TASK_RUNNING) pthread_cond_wait(&task->cond, &_lock);
+    task->fn(task->arg);
+    vTaskDelete(NULL);
+    return NULL;
+}
+
+static BaseType_t _block(uint64_t wake, struct sim_sem *sem) { //called by the running task with _lock held
+    struct sim_task *task=_current;
+    task->state=TASK_BLOCKED;
+    task->wake=wake;
+    task->sem=sem;
+    task->result=pdFALSE;
+    pthread_cond_signal(&_sched);
+    while (task->state!=TASK_RUNNING) pthread_cond_wait(&task->cond, &_lock);
+    return task->result;
+}
+
+BaseType_t xTaskCreate(void (*fn)(void *), const char *name, uint16_t stack, void *arg, UBaseType_t prio, TaskHandle_t *handle) {
+    struct sim_task *task=calloc(1, sizeof(*task)), **tail;
+    task->fn=fn;
+    task->arg=arg;
+    task->name=name;
+    task->stack=stack;
+    task->state=TASK_READY;
+    task->wake=UINT64_MAX;
+    pthread_cond_init(&task->cond, NULL);
+    for (tail=&_tasks; *tail; tail=&(*tail)->next); //keep creation order for round robin
+    *tail=task;
+    pthread_create(&task->thread, NULL, _task_main, task);
+    if (handle) *handle=task;
+    return pdPASS;
+}
+
+void vTaskDelete(TaskHandle_t task) {
+    if (task && task!=_current) {
+        task->state=TASK_DELETED;
+        return;
+    }
+    _current->state=TASK_DELETED;
+    pthread_cond_signal(&_sched);
+    pthread_mutex_unlock(&_lock);
+    pthread_exit(NULL);
+}
+
+void vTaskDelay(TickType_t ticks) {
+    _block(_now+(uint64_t)ticks*portTICK_PERIOD_MS*1000, NULL);
+}
+
+TickType_t xTaskGetTickCount(void) {
+    return _now/(portTICK_PERIOD_MS*1000);
+}
+
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t task) { //host stacks say nothing about the ESP, report it untouched
+    task=task?task:_current;
+    return task?task->stack:0;
+}
+
+size_t xPortGetFreeHeapSize(void) { //heap is not modelled
+    return 0;
+}
+
+/* ---- semaphores ---- */
+
+SemaphoreHandle_t xSemaphoreCreateBinary(void) {
+    return calloc(1, sizeof(struct sim_sem));
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t sem, TickType_t ticks) {
+    if (sem->count) {
+        sem->count=0;
+        return pdTRUE;
+    }
+    if (!ticks) return pdFALSE;
+    return _block((ticks==portMAX_DELAY)?UINT64_MAX:_now+(uint64_t)ticks*portTICK_PERIOD_MS*1000, sem);
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t sem) {
+    for (struct sim_task *task=_tasks; task; task=task->next) {
+        if (task->state==TASK_BLOCKED && task->sem==sem) { //hand it straight to the waiter
+            task->state=TASK_READY;
+            task->sem=NULL;
+            task->result=pdTRUE;
+            return pdTRUE;
+        }
+    }
+    if (sem->count) return pdFALSE;
+    sem->count=1;
+    return pdTRUE;
+}
+
+BaseType_t xSemaphoreGiveFromISR(SemaphoreHandle_t sem, BaseType_t *yield) {
+    return xSemaphoreGive(sem);
+}
+
+/* ---- SDK ---- */
+
+uint32_t sdk_system_get_time(void) {
+    return (uint32_t)_now;
+}
+
+void sdk_os_delay_us(uint16_t us) {
+}
+
+void sdk_os_timer_setfn(ETSTimer *ptimer, ETSTimerFunc *pfunction, void *parg) {
+    ETSTimer *t;
+    ptimer->timer_func=pfunction;
+    ptimer->timer_arg=parg;
+    ptimer->expire=0;
+    for (t=_timers; t && t!=ptimer; t=t->next);
+    if (!t) {
+        ptimer->next=_timers;
+        _timers=ptimer;
+    }
+}
+
+void sdk_os_timer_arm(ETSTimer *ptimer, uint32_t milliseconds, bool repeat_flag) {
+    ptimer->expire=_now+(uint64_t)milliseconds*1000;
+    ptimer->period=repeat_flag?milliseconds:0;
+}
+
+void sdk_os_timer_disarm(ETSTimer *ptimer) {
+    ptimer->expire=0;
+}
+
+void gpio_enable(uint8_t gpio_num, gpio_direction_t direction) {
+}
+
+void gpio_set_pullup(uint8_t gpio_num, bool enabled, bool enabled_during_sleep) {
+}
+
+void gpio_write(uint8_t gpio_num, bool set) {
+    if (gpio_num<SIM_GPIO_N) _level[gpio_num]=set;
+}
+
+void gpio_set_interrupt(uint8_t gpio_num, gpio_inttype_t int_type, gpio_interrupt_handler_t handler) {
+    if (gpio_num<SIM_GPIO_N) _handler[gpio_num]=(int_type==GPIO_INTTYPE_NONE)?NULL:handler;
+}
+
+bool sim_gpio_level(uint8_t gpio_num) {
+    return gpio_num<SIM_GPIO_N && _level[gpio_num];
+}
+
+void sim_gpio_interrupt(uint8_t gpio_num) {
+    if (gpio_num<SIM_GPIO_N && _handler[gpio_num]) _handler[gpio_num](gpio_num);
+}
+
+void sim_sysparam_int32(const char *key, int32_t value) {
+    for (int i=0; i<8; i++) {
+        if (!_sysparam[i].key || !strcmp(_sysparam[i].key, key)) {
+            _sysparam[i].key=key;
+            _sysparam[i].value=value;
+            return;
+        }
+    }
+}
+
+sysparam_status_t sysparam_get_int32(const char *key, int32_t *result) {
+    for (int i=0; i<8 && _sysparam[i].key; i++) {
+        if (!strcmp(_sysparam[i].key, key)) {
+            *result=_sysparam[i].value;
+            return SYSPARAM_OK;
+        }
+    }
+    return SYSPARAM_NOTFOUND;
+}
+
+sysparam_status_t sysparam_set_int32(const char *key, int32_t value) {
+    return SYSPARAM_OK; //calibration is not persisted between runs
+}
+
+/* ---- scheduler ---- */
+
+void sim_run(uint64_t until) { //call from the main thread once user_init has created the tasks
+    struct sim_task *task, *last=NULL;
+    ETSTimer *timer;
+    uint64_t next;
+
+    pthread_mutex_lock(&_lock);
+    while (1) {
+        // run every ready task until it blocks, round robin
+        for (task=last?last->next:_tasks; task && task->state!=TASK_READY; task=task->next);
+        if (!task) for (task=_tasks; task && task->state!=TASK_READY; task=task->next);
+        if (task) {
+            _current=last=task;
+            task->state=TASK_RUNNING;
+            pthread_cond_signal(&task->cond);
+            while (task->state==TASK_RUNNING) pthread_cond_wait(&_sched, &_lock);
+            _current=NULL;
+            continue;
+        }
+        // all blocked: advance to the next pulse, timer or timeout
+        next=pulses_next();
+        for (timer=_timers; timer; timer=timer->next) if (timer->expire && timer->expire<next) next=timer->expire;
+        for (task=_tasks; task; task=task->next) if (task->state==TASK_BLOCKED && task->wake<next) next=task->wake;
+        if (next>until) break;
+        _now=next;
+        for (timer=_timers; timer; timer=timer->next) {
+            if (timer->expire && timer->expire<=_now) {
+                timer->expire=timer->period?_now+(uint64_t)timer->period*1000:0;
+                timer->timer_func(timer->timer_arg);
+            }
+        }
+        if (pulses_next()<=_now) pulses_fire();
+        for (task=_tasks; task; task=task->next) {
+            if (task->state==TASK_BLOCKED && task->wake<=_now) { //timed out
+                task->state=TASK_READY;
+                task->sem=NULL;
+            }
+        }
+    }
+    _now=until;
+    pthread_mutex_unlock(&_lock); //tasks stay parked, the process exits after the report
+}
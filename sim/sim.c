@@ -0,0 +1,287 @@
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+#include <getopt.h>
+#include <homekit/homekit.h>
+#include <homekit/characteristics.h>
+#include <metrics.h>
+#include <ota-api.h>
+#include <main.h>
+#include "sim.h"
+
+// pulse rates of the default calibration hard coded in main.c
+#define CF_US_PER_W     1668220.0
+#define CF1V_US_PER_V   142000.0
+#define CF1A_US_PER_MA  13118710.0
+
+#define SIM_STEPS_N     32
+#define SIM_TAIL        150     //seconds after the last step, the firmware needs up to 12 timeouts of 10s to report no load
+
+void user_init(void);
+extern const int CF_GPIO, CF1_GPIO, SELi_GPIO;
+
+typedef enum {
+    PROFILE_CONTINUOUS,
+    PROFILE_BURST,      //a on, b off whole mains cycles
+    PROFILE_PHASE,      //conducts the last fraction a of every half cycle
+} profile_t;
+
+typedef struct {
+    double              time;       //microseconds
+    double              watts;      //average
+    profile_t           profile;
+    double              a, b;
+} step_t;
+
+typedef struct {
+    double              t;          //time of the latest pulse
+    double              next;       //time of the next pulse, INFINITY if none
+    bool                voltage;    //CF1 only: SEL selects the voltage channel
+} channel_t;
+
+static step_t    _steps[SIM_STEPS_N] = {
+    {  0e6,   60, PROFILE_CONTINUOUS},  //lamp
+    { 20e6, 1500, PROFILE_BURST, 8, 8}, //burst-fire heater, 3kW elements at half duty
+    { 40e6,  300, PROFILE_PHASE, 0.4},  //dimmed load
+    { 60e6,    5, PROFILE_CONTINUOUS},  //standby
+    { 80e6,    0, PROFILE_CONTINUOUS},  //off
+};
+static int       _step_n=5;
+static double    _period=20000;     //mains period in microseconds
+static double    _volts=230;
+static channel_t _cf, _cf1;
+
+/* ---- not simulated firmware parts ---- */
+
+metrics_snapshot_t metrics;
+
+void metrics_init(void) { //no network on the host, the snapshot is still written
+}
+
+unsigned int ota_read_sysparam(char **manufacturer, char **serial, char **model, char **revision) {
+    *manufacturer="HomeACcessoryKid";
+    *serial="00:00:00:00:00:00";
+    *model="NAS-WR01W";
+    *revision="0.0.0";
+    return 1;
+}
+
+void ota_set(homekit_value_t value) {
+}
+
+/* ---- load scenario ---- */
+
+static int _step_at(double t) {
+    int i=0;
+    while (i+1<_step_n && _steps[i+1].time<=t) i++;
+    return i;
+}
+
+static double _segment(double t, double *end) { //rate multiplier from t up to end
+    int i=_step_at(t);
+    const step_t *s=&_steps[i];
+    double mult=1, pos, len, on;
+
+    *end=(i+1<_step_n)?_steps[i+1].time:INFINITY;
+    switch (s->profile) {
+        case PROFILE_BURST:
+            len=(s->a+s->b)*_period;
+            on=s->a*_period;
+            pos=fmod(t, len);
+            if (pos<on) {mult=(s->a+s->b)/s->a; len=t-pos+on;} else {mult=0; len=t-pos+len;}
+            break;
+        case PROFILE_PHASE:
+            len=_period/2;
+            on=len*(1-s->a);
+            pos=fmod(t, len);
+            if (pos<on) {mult=0; len=t-pos+on;} else {mult=1/s->a; len=t-pos+len;}
+            break;
+        default:
+            len=INFINITY;
+    }
+    if (len<*end) *end=len;
+    if (*end<=t) *end=t+1e-3; //rounding at a segment edge
+    return mult;
+}
+
+static double _rate(channel_t *c, double t) { //average pulses per microsecond of the running step
+    const step_t *s=&_steps[_step_at(t)];
+    if (c==&_cf) return s->watts/CF_US_PER_W;
+    if (c->voltage) return _volts/CF1V_US_PER_V;
+    return s->watts/_volts*1000/CF1A_US_PER_MA;
+}
+
+static double _next_pulse(channel_t *c, double t) {
+    double acc=0, end, rate;
+    while (t<INFINITY) {
+        rate=_rate(c, t);
+        if (!(c==&_cf1 && c->voltage)) rate*=_segment(t, &end); //voltage pulses do not follow the load
+        else end=(_step_at(t)+1<_step_n)?_steps[_step_at(t)+1].time:INFINITY;
+        if (rate>0 && t+(1-acc)/rate<=end) return t+(1-acc)/rate;
+        if (rate>0) acc+=rate*(end-t);
+        t=end;
+    }
+    return INFINITY;
+}
+
+uint64_t pulses_next(void) {
+    bool voltage=sim_gpio_level(SELi_GPIO);
+    if (voltage!=_cf1.voltage) { //BL0937 switched CF1 between voltage and current
+        _cf1.voltage=voltage;
+        _cf1.t=sim_now();
+        _cf1.next=_next_pulse(&_cf1, _cf1.t);
+    }
+    double next=(_cf.next<_cf1.next)?_cf.next:_cf1.next;
+    return (next<INFINITY)?(uint64_t)ceil(next):UINT64_MAX;
+}
+
+void pulses_fire(void) {
+    channel_t *c=(_cf.next<_cf1.next)?&_cf:&_cf1;
+    c->t=c->next;
+    c->next=_next_pulse(c, c->t);
+    sim_gpio_interrupt((c==&_cf)?CF_GPIO:CF1_GPIO);
+}
+
+static int _load(const char *path) {
+    FILE *f=fopen(path, "r");
+    char line[128], name[16];
+    double seconds, watts, a, b;
+    int n;
+
+    if (!f) return -1;
+    _step_n=0;
+    while (fgets(line, sizeof(line), f) && _step_n<SIM_STEPS_N) {
+        if (line[0]=='#') continue;
+        n=sscanf(line, "%lf %lf %15s %lf %lf", &seconds, &watts, name, &a, &b);
+        if (n<2) continue;
+        _steps[_step_n]=(step_t){.time=seconds*1e6, .watts=watts, .profile=PROFILE_CONTINUOUS};
+        if (n>=5 && !strcmp(name, "burst") && a>0 && b>=0) {
+            _steps[_step_n].profile=PROFILE_BURST;
+            _steps[_step_n].a=a;
+            _steps[_step_n].b=b;
+        } else if (n>=4 && !strcmp(name, "phase") && a>0 && a<=1) {
+            _steps[_step_n].profile=PROFILE_PHASE;
+            _steps[_step_n].a=a;
+        }
+        _step_n++;
+    }
+    fclose(f);
+    return _step_n?0:-1;
+}
+
+/* ---- report ---- */
+
+static const char *_profile_name[]={"continuous", "burst", "phase"};
+
+static double _value(const sim_event_t *e) {
+    return (e->value.format==homekit_format_float)?e->value.float_value:e->value.int_value;
+}
+
+static void _latency(FILE *out, const char *type, double expected, double tolerance, int step) {
+    double from=_steps[step].time, to=(step+1<_step_n)?_steps[step+1].time:INFINITY;
+    for (uint32_t i=0; i<sim_event_count; i++) {
+        const sim_event_t *e=&sim_events[i];
+        if (e->time<from || strcmp(e->ch->type, type)) continue;
+        if (e->time>=to) break;
+        if (fabs(_value(e)-expected)<=tolerance) {
+            fprintf(out, " %8.2f", (e->time-from)/1e6);
+            return;
+        }
+    }
+    fprintf(out, " %8s", "never");
+}
+
+static void _report(FILE *out, double seconds) {
+    homekit_characteristic_t *chs[16];
+    uint32_t events[16]={0}, bytes[16]={0}, total=0, count=0, messages=0;
+    int n=0, i, j;
+
+    for (i=0; i<(int)sim_event_count; i++) {
+        for (j=0; j<n && chs[j]!=sim_events[i].ch; j++);
+        if (j==n && n<16) chs[n++]=sim_events[i].ch;
+        if (j<n) {
+            events[j]++;
+            bytes[j]+=sim_events[i].bytes;
+        }
+        total+=sim_events[i].bytes;
+        messages+=sim_events[i].message;
+        count++;
+    }
+    fprintf(out, "simulated %.0f s, mains %.0f Hz, %d subscribed clients\n\n", seconds, 1e6/_period, sim_clients);
+    fprintf(out, "%-20s %8s %10s %14s\n", "characteristic", "events", "events/s", "bytes/client");
+    for (j=0; j<n; j++) {
+        fprintf(out, "%-20s %8u %10.2f %14u\n", chs[j]->description, events[j], events[j]/seconds, bytes[j]);
+    }
+    fprintf(out, "%-20s %8u %10.2f %14u\n", "total", count, count/seconds, total);
+    fprintf(out, "\n%u EVENT messages, events at the same instant share one as esp-homekit batches its queue\n", messages);
+    fprintf(out, "per client %.1f B/s, all clients %.1f B/s, %.2f events/s, %.2f messages/s\n\n",
+            total/seconds, (double)total*sim_clients/seconds, (double)count*sim_clients/seconds, (double)messages*sim_clients/seconds);
+
+    fprintf(out, "%8s %8s %-18s %8s %8s   (latency in s to a reading within 5%%)\n", "step", "watts", "load", "WATTS", "mAMPS");
+    for (i=0; i<_step_n; i++) {
+        char load[32];
+        if (_steps[i].profile==PROFILE_BURST) snprintf(load, sizeof(load), "burst %g/%g", _steps[i].a, _steps[i].b);
+        else if (_steps[i].profile==PROFILE_PHASE) snprintf(load, sizeof(load), "phase %g", _steps[i].a);
+        else snprintf(load, sizeof(load), "%s", _profile_name[_steps[i].profile]);
+        fprintf(out, "%7.1fs %8.1f %-18s", _steps[i].time/1e6, _steps[i].watts, load);
+        _latency(out, HOMEKIT_CHARACTERISTIC_CUSTOM_WATTS, _steps[i].watts, fmax(0.05*_steps[i].watts, 0.5), i);
+        _latency(out, HOMEKIT_CHARACTERISTIC_CUSTOM_MAMPS, _steps[i].watts/_volts*1000, fmax(0.05*_steps[i].watts/_volts*1000, 5), i);
+        fprintf(out, "\n");
+    }
+}
+
+static void _csv(const char *path) {
+    FILE *f=fopen(path, "w");
+    if (!f) return;
+    fprintf(f, "time_s,characteristic,value,bytes_per_client\n");
+    for (uint32_t i=0; i<sim_event_count; i++) {
+        fprintf(f, "%.6f,%s,%g,%u\n", sim_events[i].time/1e6, sim_events[i].ch->description, _value(&sim_events[i]), sim_events[i].bytes);
+    }
+    fclose(f);
+}
+
+static void _usage(const char *name) {
+    fprintf(stderr, "usage: %s [-t seconds] [-c clients] [-m mains_hz] [-V volts] [-s scenario] [-e events.csv] [-v]\n"
+                    "scenario lines: <seconds> <watts> [continuous | burst <on> <off> | phase <fraction>]\n", name);
+    exit(1);
+}
+
+int main(int argc, char **argv) {
+    double seconds=-1;
+    int hz=50, opt;
+    bool verbose=false;
+    const char *csv=NULL;
+    FILE *out;
+
+    while ((opt=getopt(argc, argv, "t:c:m:V:s:e:v"))!=-1) {
+        switch (opt) {
+            case 't': seconds=atof(optarg); if (seconds<=0) _usage(argv[0]); break;
+            case 'c': sim_clients=atoi(optarg); break;
+            case 'm': hz=atoi(optarg); break;
+            case 'V': _volts=atof(optarg); break;
+            case 's': if (_load(optarg)) {fprintf(stderr, "cannot read scenario %s\n", optarg); return 1;} break;
+            case 'e': csv=optarg; break;
+            case 'v': verbose=true; break;
+            default: _usage(argv[0]);
+        }
+    }
+    if (hz<40 || hz>70 || _volts<=0 || sim_clients<0) _usage(argv[0]);
+    if (seconds<0) seconds=_steps[_step_n-1].time/1e6+SIM_TAIL;
+    _period=1e6/hz;
+    sim_sysparam_int32("mains_hz", hz);
+
+    out=fdopen(dup(STDOUT_FILENO), "w");
+    if (!verbose) freopen("/dev/null", "w", stdout); //firmware logging
+
+    _cf.next=_next_pulse(&_cf, 0);
+    _cf1.next=_next_pulse(&_cf1, 0);
+    user_init();
+    sim_run((uint64_t)(seconds*1e6));
+    fflush(stdout);
+
+    _report(out, seconds);
+    if (csv) _csv(csv);
+    fclose(out);
+    exit(0);
+}
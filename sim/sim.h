@@ -0,0 +1,37 @@
+// host simulator of the NAS-WR01W firmware: virtual time, simulated BL0937 pulses and a HomeKit server stand-in
+#ifndef SIM_H
+#define SIM_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <esp8266.h>
+#include <homekit/homekit.h>
+
+#define SIM_GPIO_N 17
+
+// rtos.c: tasks run one at a time as threads, time only advances when all of them are blocked
+uint64_t sim_now(void);                 //virtual microseconds since boot
+void     sim_run(uint64_t until);
+bool     sim_gpio_level(uint8_t gpio_num);
+void     sim_gpio_interrupt(uint8_t gpio_num);
+void     sim_sysparam_int32(const char *key, int32_t value);
+
+// sim.c: the load scenario drives the pulse trains
+uint64_t pulses_next(void);             //time of the next CF or CF1 pulse, UINT64_MAX if none
+void     pulses_fire(void);             //deliver that pulse, sim_now() equals pulses_next()
+
+// homekit.c: every notification is recorded and costed per subscribed client
+typedef struct {
+    uint64_t            time;
+    homekit_characteristic_t *ch;
+    homekit_value_t     value;
+    uint32_t            bytes;          //added on the wire per client, including HAP session framing
+    bool                message;        //opened a new EVENT message, else joined the one sent at the same instant
+} sim_event_t;
+
+extern sim_event_t *sim_events;
+extern uint32_t     sim_event_count;
+extern int          sim_clients;
+
+#endif